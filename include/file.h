@@ -2,9 +2,22 @@
 #define FILE_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+typedef struct file_batch FileBatch;
 
 char *file_read(const char *file_name);
 void file_write(const char *file_name, const char *src);
 char *file_asm_name(const char *file_name); // Replaces the file extension to .asm and if it doesn't exist it adds it
+char *file_interface_name(const char *file_name); // Same as file_asm_name but for the .kei module interface file
+
+// Reads and writes many files at once through io_uring, falling back to blocking I/O if the kernel doesn't support it.
+// Requests run in the background until their result is needed, so I/O overlaps with compiling other files.
+FileBatch *file_batch_create(void);
+void file_batch_free(FileBatch *batch); // Waits for every outstanding write to finish
+
+uint32_t file_batch_read(FileBatch *batch, const char *file_name); // Returns the index to pass to file_batch_wait
+char *file_batch_wait(FileBatch *batch, uint32_t index); // Returns the contents like file_read does
+void file_batch_write(FileBatch *batch, const char *file_name, char *contents); // Takes ownership of contents
 
 #endif // FILE_H
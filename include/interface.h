@@ -0,0 +1,56 @@
+#ifndef INTERFACE_H
+#define INTERFACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "symbol_table.h"
+
+// Binary module interface (.kei) files. Everything an importer needs is stored with fixed width fields at 8 byte aligned
+// offsets, so the file is mapped and used in place:
+//
+//   InterfaceHeader
+//   InterfaceEntry entries[export_count]
+//   uint32_t buckets[bucket_count]   index + 1 of the first entry of each hash chain, 0 if empty
+//   char strings[]                   null terminated names and type signatures
+
+#define INTERFACE_MAGIC      0x4941454B // "KEAI"
+#define INTERFACE_VERSION    2
+#define INTERFACE_BYTE_ORDER 0x01020304 // Files are written in native layout, so ones from a machine with another byte order are rejected
+
+typedef struct {
+	uint32_t magic, version;
+	uint32_t byte_order, entry_size;
+	uint32_t export_count, bucket_count; // bucket_count is a power of two
+	uint32_t entries_offset, buckets_offset, strings_offset;
+	uint32_t file_size;
+} InterfaceHeader;
+
+typedef struct {
+	uint32_t name_offset, name_length; // Relative to strings_offset
+	uint32_t type_offset, type_length;
+	uint32_t hash;
+	uint32_t next; // index + 1 of the next entry in the same bucket, 0 if last
+	uint64_t offset;
+} InterfaceEntry;
+
+typedef struct {
+	const Symbol *symbol;
+	const char *type; // Type signature
+	uint64_t offset;
+} InterfaceExport;
+
+typedef struct interface Interface;
+
+void interface_write(const char *file_name, const InterfaceExport *exports, uint32_t export_count);
+
+Interface *interface_open(const char *file_name);
+void interface_close(Interface *interface);
+
+// Returns NULL if the module doesn't export name. The entry points into the mapped file.
+// Every index and offset is bounds checked as it is followed, a corrupt file is reported as an error.
+const InterfaceEntry *interface_lookup(const Interface *interface, const char *name, size_t length);
+const char *interface_name(const Interface *interface, const InterfaceEntry *entry);
+const char *interface_type(const Interface *interface, const InterfaceEntry *entry);
+
+#endif // INTERFACE_H
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 
-char *keac_compile(const char *file_name);
+char *keac_compile(const char *file_name, const char *src); // src is the contents of file_name, still owned by the caller
 void keac_error(const char *file, uint64_t line, uint64_t column, const char *message, ...);
 
 #endif // KEAC_H
@@ -84,16 +84,21 @@ typedef struct lexer Lexer;
 
 typedef struct {
 	TokenType type;
-	Symbol *value; // If the token is an identifier, it will point to the symbol table entry for that identifier
+	Symbol *value; // Symbol table entry of identifiers and literals, string and character literals point into the literal table as they are spelled
 	uint64_t line, column;
 } Token;
 
-Lexer *lexer_create(const char *src, const char *file_name, SymbolTable *table);
+Lexer *lexer_create(const char *src, const char *file_name, SymbolTable *table, SymbolTable *literals);
 void lexer_free(Lexer *lexer);
 
 // Returns the next token from
 Token *lexer_next_token(Lexer *lexer);
 
+// Returns the literal table entry holding the value of a string or character literal token, so "A" and "\x41" give the
+// same symbol. Escapes are decoded the first time the value is asked for and the result is cached on the literal.
+// The id of the returned symbol is the decoded value, which can contain null characters, so id_length must be used.
+Symbol *lexer_literal_value(SymbolTable *literals, Symbol *literal);
+
 // Returns the name of the token enum value passed in
 const char *lexer_str_token(TokenType token);
 
@@ -0,0 +1,27 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stddef.h>
+
+// Every allocation is tagged with the subsystem it belongs to so that memory usage can be reported with --stats=mem
+typedef enum {
+	MEM_FILE,
+	MEM_LEXER,
+	MEM_SYMTAB,
+	MEM_SCOPE,
+	MEM_INTERFACE,
+	MEM_VM,
+	MEM_TAG_COUNT
+} MemTag;
+
+// All of these exit with an error if the allocation fails, so their result never needs to be checked
+void *mem_alloc(MemTag tag, size_t size);
+void *mem_calloc(MemTag tag, size_t count, size_t size);
+// Behaves like mem_alloc if ptr is NULL, resizing counts as a reallocation rather than a new allocation
+void *mem_realloc(MemTag tag, void *ptr, size_t size);
+void mem_free(void *ptr);
+
+// Prints live bytes, peak bytes and allocation count of every subsystem to stderr
+void mem_print_stats(void);
+
+#endif // MEM_H
@@ -0,0 +1,10 @@
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+// Returns the offset of the first occurrence of a, b or c in src, or length if there is none.
+// Compares 16 bytes at a time when SSE2 is available, pass the same character more than once to search for fewer.
+size_t scan_until(const char *src, size_t length, char a, char b, char c);
+
+#endif // SCAN_H
@@ -0,0 +1,40 @@
+#ifndef SCOPE_H
+#define SCOPE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "symbol_table.h"
+
+typedef struct binding {
+	Symbol *symbol;
+	void *value; // What the name is bound to (declaration, type, ...), owned by the caller
+	uint32_t depth; // Depth of the scope the binding was made in
+	uint32_t shadowed; // Binding of the same symbol in an outer scope, 0 if there is none
+} Binding;
+
+// Bindings are kept in a single stack that doubles as the undo log: every symbol points to its innermost binding,
+// and leaving a scope pops its bindings and restores whatever they shadowed. Entering, leaving and resolving are all O(1)
+// (per binding) and never look at the identifier string again.
+typedef struct scope_stack {
+	Binding *bindings;
+	size_t binding_count, binding_capacity;
+
+	size_t *marks; // binding_count at the time each open scope was entered
+	uint32_t depth;
+	size_t marks_capacity;
+} ScopeStack;
+
+ScopeStack *scope_create(void);
+void scope_free(ScopeStack *scopes);
+
+void scope_enter(ScopeStack *scopes);
+void scope_exit(ScopeStack *scopes);
+
+// Returns NULL if the symbol is already bound in the current scope
+Binding *scope_bind(ScopeStack *scopes, Symbol *symbol, void *value);
+// Returns the innermost visible binding of the symbol or NULL if it is unbound.
+// The pointer is only valid until the next call to scope_bind.
+Binding *scope_resolve(ScopeStack *scopes, const Symbol *symbol);
+
+#endif // SCOPE_H
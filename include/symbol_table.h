@@ -3,17 +3,21 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef struct symbol {
 	char *id;
 	size_t id_length;
 
+	uint32_t binding; // Innermost scope binding of this symbol (see scope.h), 0 if unbound
+	struct symbol *literal_value; // Literal tables only, cached result of lexer_literal_value
+
 	struct symbol *next;
 } Symbol;
 
 typedef struct symbol_table {
 	size_t table_size;
-	Symbol *table;
+	Symbol **table; // Chain heads, symbols are never moved once added so pointers to them stay valid
 	uint32_t entry_count;
 } SymbolTable;
 
@@ -22,7 +26,10 @@ void st_free(SymbolTable *table);
 
 Symbol *st_get_symbol(SymbolTable *table, const char *value);
 Symbol *st_add_symbol(SymbolTable *table, const char *value);
-void st_remove_symbol(SymbolTable *table, const char *value);
+// Returns the symbol for the first length characters of value, adding it if it doesn't exist yet
+Symbol *st_intern(SymbolTable *table, const char *value, size_t length);
+// Returns false without removing anything if the symbol doesn't exist or is still bound in a scope
+bool st_remove_symbol(SymbolTable *table, const char *value);
 void sb_print(SymbolTable *table);
 
 #endif // SYMBOL_TABLE_H
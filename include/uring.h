@@ -0,0 +1,26 @@
+#ifndef URING_H
+#define URING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	URING_READ,
+	URING_WRITE
+} UringOperation;
+
+typedef struct uring Uring;
+
+// Returns NULL if io_uring isn't available (not Linux, kernel older than 5.6 or disabled), callers then fall back to blocking I/O
+Uring *uring_create(uint32_t entries);
+void uring_free(Uring *ring);
+
+// Queues a read or write without submitting it. Returns false if the submission queue is full.
+bool uring_queue(Uring *ring, UringOperation operation, int fd, void *buffer, uint32_t length, uint64_t offset, uint64_t user_data);
+// Submits everything queued so far with a single system call
+void uring_submit(Uring *ring);
+// Pops one completion. If wait is true, blocks until one is available, otherwise returns false if there is none.
+// result is the number of bytes transferred or a negative errno.
+bool uring_complete(Uring *ring, bool wait, uint64_t *user_data, int32_t *result);
+
+#endif // URING_H
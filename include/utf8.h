@@ -0,0 +1,19 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Returns the offset of the first byte that is not part of a well-formed UTF-8 sequence, or length if the whole buffer is valid.
+// Runs of ASCII are skipped 16 bytes at a time when SSE2 is available.
+size_t utf8_validate(const char *src, size_t length);
+
+// Decodes the code point starting at src into *code_point and returns its length in bytes.
+// src must already have been validated.
+uint32_t utf8_decode(const char *src, uint32_t *code_point);
+
+bool utf8_is_identifier_start(uint32_t code_point);
+bool utf8_is_identifier_part(uint32_t code_point);
+
+#endif // UTF8_H
@@ -0,0 +1,63 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define VM_REGISTER_COUNT 256
+
+// Register based bytecode for running Kea programs without assembling and linking them. a is the destination register
+// unless stated otherwise, b and c are source registers.
+typedef enum {
+	OP_LOAD_CONST,     // R[a] = constants[operand]
+	OP_MOVE,           // R[a] = R[b]
+	OP_ADD,
+	OP_SUB,
+	OP_MUL,
+	OP_DIV,
+	OP_MOD,
+	OP_AND,
+	OP_OR,
+	OP_XOR,
+	OP_SHL,
+	OP_SHR,
+	OP_EQUAL,
+	OP_NOT_EQUAL,
+	OP_LESS_THAN,
+	OP_LESS_EQUAL,
+	OP_INCREMENT,      // ++R[a]
+	OP_DECREMENT,      // --R[a]
+	OP_JUMP,           // ip += operand
+	OP_JUMP_IF_FALSE,  // if (!R[a]) ip += operand
+	OP_JUMP_IF_TRUE,   // if (R[a]) ip += operand
+	OP_LOOP_INC_LT,    // if (++R[a] < R[b]) ip += operand, the increment and condition of a for (i = x; i < n; ++i) loop
+	OP_JUMP_IF_NOT_LT, // if (!(R[a] < R[b])) ip += operand, a < condition followed by OP_JUMP_IF_FALSE
+	OP_JUMP_IF_NOT_LE, // if (!(R[a] <= R[b])) ip += operand, a <= condition followed by OP_JUMP_IF_FALSE
+	OP_RETURN,         // returns R[a]
+	OP_COUNT
+} Opcode;
+
+typedef struct {
+	uint8_t opcode, a, b, c;
+	int32_t operand; // Constant index or jump offset relative to the instruction itself
+} Instruction;
+
+typedef struct {
+	Instruction *code;
+	size_t code_count, code_capacity;
+
+	int64_t *constants;
+	uint32_t constant_count, constant_capacity;
+} Chunk;
+
+Chunk *vm_chunk_create(void);
+void vm_chunk_free(Chunk *chunk);
+
+// Returns the index of the emitted instruction so that jumps can be patched once their target is known
+size_t vm_emit(Chunk *chunk, Opcode opcode, uint8_t a, uint8_t b, uint8_t c, int32_t operand);
+uint32_t vm_add_constant(Chunk *chunk, int64_t value);
+
+// Runs the chunk until OP_RETURN and returns the returned value
+int64_t vm_run(const Chunk *chunk);
+
+#endif // VM_H
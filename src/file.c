@@ -1,32 +1,83 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "file.h"
+#include "mem.h"
+#include "uring.h"
+
+#define BATCH_RING_ENTRIES 64
+#define BATCH_INITIAL_CAPACITY 16
+#define BATCH_MAX_TRANSFER 0x7FFFF000 // Linux never transfers more than this in a single read or write
+
+typedef enum {
+	REQUEST_PENDING,
+	REQUEST_IN_FLIGHT,
+	REQUEST_FINISHED
+} RequestState;
+
+typedef enum {
+	OPEN_TRANSFER, // The file is open and its transfer can be queued
+	OPEN_EMPTY, // There is nothing to transfer, the request is already finished
+	OPEN_NO_FILES // Out of file descriptors, the request has to wait until an in-flight one closes its file
+} OpenResult;
+
+typedef struct {
+	char *file_name;
+	int fd;
+	bool is_write;
+	RequestState state;
+
+	char *buffer;
+	size_t size, done;
+} FileRequest;
+
+typedef struct file_batch {
+	Uring *ring; // NULL when falling back to blocking I/O
+	uint32_t in_flight;
+
+	FileRequest *requests;
+	uint32_t request_count, request_capacity;
+	uint32_t next_pending; // Requests are started in the order they were added
+} FileBatch;
 
 static uint32_t get_extension_index(const char *file_name);
+static char *replace_extension(const char *file_name, const char *extension);
+static void check_extension(const char *file_name);
+
+static FileRequest *add_request(FileBatch *batch, const char *file_name, bool is_write);
+static void start_requests(FileBatch *batch);
+static OpenResult open_request(FileBatch *batch, uint32_t index);
+static void queue_transfer(FileBatch *batch, uint32_t index);
+static void finish_request(FileBatch *batch);
 
 char *file_read(const char *file_name)
 {
 	FILE *file = fopen(file_name, "r");
 	if (file == NULL) {
-		fprintf(stderr, "error: %s: cannot open file\n", file_name);
+		fprintf(stderr, "error: %s: cannot open file: %s\n", file_name, strerror(errno));
 		exit(EXIT_FAILURE);
 	}
 
-	uint32_t extension_index = get_extension_index(file_name);
-	if (extension_index != 0 && strcmp(file_name + extension_index, ".ke") != 0) {
-		fprintf(stderr, "error: %s: unrecognised file format\n", file_name);
-		exit(EXIT_FAILURE);
-	}
+	check_extension(file_name);
 
 	fseek(file, 0, SEEK_END);
 	size_t file_size = ftell(file);
 	fseek(file, 0, SEEK_SET);
 
-	char *buffer = malloc(file_size + 1);
-	fread(buffer, sizeof(char), file_size, file);
+	char *buffer = mem_alloc(MEM_FILE, file_size + 1);
+	if (fread(buffer, sizeof(char), file_size, file) != file_size) {
+		fprintf(stderr, "error: %s: cannot read file\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+	buffer[file_size] = '\0';
 
 	fclose(file);
 
@@ -41,26 +92,255 @@ void file_write(const char *file_name, const char *contents)
 	fclose(file);
 }
 
+FileBatch *file_batch_create(void)
+{
+	FileBatch *batch = mem_alloc(MEM_FILE, sizeof(FileBatch));
+
+	batch->ring = uring_create(BATCH_RING_ENTRIES);
+	batch->in_flight = 0;
+
+	batch->request_count = 0;
+	batch->request_capacity = BATCH_INITIAL_CAPACITY;
+	batch->requests = mem_alloc(MEM_FILE, batch->request_capacity * sizeof(FileRequest));
+	batch->next_pending = 0;
+
+	return batch;
+}
+
+void file_batch_free(FileBatch *batch)
+{
+	while (batch->ring != NULL && (batch->next_pending != batch->request_count || batch->in_flight != 0)) {
+		start_requests(batch);
+		if (batch->in_flight != 0)
+			finish_request(batch);
+	}
+
+	// Reads that were never waited on still own their buffer
+	for (uint32_t i = 0; i < batch->request_count; ++i) {
+		mem_free(batch->requests[i].file_name);
+		mem_free(batch->requests[i].buffer);
+	}
+
+	if (batch->ring != NULL)
+		uring_free(batch->ring);
+	mem_free(batch->requests);
+	mem_free(batch);
+}
+
+// Files are only opened once their request starts, so there are never more than BATCH_RING_ENTRIES open at a time
+uint32_t file_batch_read(FileBatch *batch, const char *file_name)
+{
+	add_request(batch, file_name, false);
+	start_requests(batch);
+
+	return batch->request_count - 1;
+}
+
+char *file_batch_wait(FileBatch *batch, uint32_t index)
+{
+	if (batch->ring == NULL && batch->requests[index].state != REQUEST_FINISHED) {
+		batch->requests[index].buffer = file_read(batch->requests[index].file_name);
+		batch->requests[index].state = REQUEST_FINISHED;
+	}
+
+	while (batch->requests[index].state != REQUEST_FINISHED) {
+		start_requests(batch);
+		if (batch->requests[index].state != REQUEST_FINISHED)
+			finish_request(batch);
+	}
+
+	// Later requests can still move the array, so the buffer is taken out before returning
+	char *buffer = batch->requests[index].buffer;
+	batch->requests[index].buffer = NULL;
+
+	return buffer;
+}
+
+void file_batch_write(FileBatch *batch, const char *file_name, char *contents)
+{
+	if (batch->ring == NULL) {
+		file_write(file_name, contents);
+		mem_free(contents);
+
+		return;
+	}
+
+	FileRequest *request = add_request(batch, file_name, true);
+	request->buffer = contents;
+	request->size = strlen(contents);
+
+	start_requests(batch);
+}
+
 char *file_asm_name(const char *file_name)
 {
-	char *asm_file_name;
+	return replace_extension(file_name, ".asm");
+}
+
+char *file_interface_name(const char *file_name)
+{
+	return replace_extension(file_name, ".kei");
+}
+
+char *replace_extension(const char *file_name, const char *extension)
+{
+	uint32_t extension_index = get_extension_index(file_name);
+	if (extension_index == 0) // No file extension
+		extension_index = strlen(file_name);
 
+	char *new_file_name = mem_alloc(MEM_FILE, extension_index + strlen(extension) + 1);
+	memcpy(new_file_name, file_name, extension_index);
+	strcpy(new_file_name + extension_index, extension);
+
+	return new_file_name;
+}
+
+void check_extension(const char *file_name)
+{
 	uint32_t extension_index = get_extension_index(file_name);
-	if (extension_index == 0) { // No file extension
-		size_t asm_file_name_len = strlen(file_name) + strlen(".asm");
+	if (extension_index != 0 && strcmp(file_name + extension_index, ".ke") != 0) {
+		fprintf(stderr, "error: %s: unrecognised file format\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+}
+
+FileRequest *add_request(FileBatch *batch, const char *file_name, bool is_write)
+{
+	if (batch->request_count == batch->request_capacity) {
+		batch->request_capacity *= 2;
+		batch->requests = mem_realloc(MEM_FILE, batch->requests, batch->request_capacity * sizeof(FileRequest));
+	}
+
+	FileRequest *request = batch->requests + batch->request_count++;
+	request->file_name = strcpy(mem_alloc(MEM_FILE, strlen(file_name) + 1), file_name);
+	request->fd = -1;
+	request->is_write = is_write;
+	request->state = REQUEST_PENDING;
+	request->buffer = NULL;
+	request->size = 0;
+	request->done = 0;
+
+	return request;
+}
+
+// Queues pending requests while the ring has room and submits them all with one system call
+void start_requests(FileBatch *batch)
+{
+	if (batch->ring == NULL)
+		return;
+
+	while (batch->next_pending != batch->request_count && batch->in_flight != BATCH_RING_ENTRIES) {
+		uint32_t index = batch->next_pending;
+
+		OpenResult result = open_request(batch, index);
+		if (result == OPEN_NO_FILES)
+			break;
+
+		++batch->next_pending;
+		if (result == OPEN_EMPTY)
+			continue;
+
+		queue_transfer(batch, index);
+		++batch->in_flight;
+	}
+
+	uring_submit(batch->ring);
+}
+
+// Opens the file of a request and sets up its buffer
+OpenResult open_request(FileBatch *batch, uint32_t index)
+{
+	FileRequest *request = batch->requests + index;
+
+	if (request->is_write)
+		request->fd = open(request->file_name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	else
+		request->fd = open(request->file_name, O_RDONLY);
+
+	if (request->fd == -1) {
+		// Every in-flight request closes its file when it finishes, so running out of descriptors is only fatal when
+		// there are none left to wait for
+		if ((errno == EMFILE || errno == ENFILE) && batch->in_flight != 0)
+			return OPEN_NO_FILES;
+
+		fprintf(stderr, "error: %s: cannot open file: %s\n", request->file_name, strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	if (!request->is_write) {
+		check_extension(request->file_name);
 
-		asm_file_name = strcpy(malloc(asm_file_name_len + 1), file_name);
-		sprintf(asm_file_name + strlen(file_name), ".asm");
+		struct stat file_stat;
+		if (fstat(request->fd, &file_stat) == -1) {
+			fprintf(stderr, "error: %s: cannot read file: %s\n", request->file_name, strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		request->size = file_stat.st_size;
+		request->buffer = mem_alloc(MEM_FILE, request->size + 1);
+		request->buffer[request->size] = '\0';
 	}
-	else {
-		// .ke has 2 characters and .asm has 3 so .asm = .ke + 1
-		size_t asm_file_name_len = strlen(file_name) + 1; 
 
-		asm_file_name = strcpy(malloc(asm_file_name_len + 1), file_name);
-		sprintf(asm_file_name + extension_index, ".asm");
+	if (request->size == 0) {
+		close(request->fd);
+		request->state = REQUEST_FINISHED;
+
+		if (request->is_write) {
+			mem_free(request->buffer);
+			request->buffer = NULL;
+		}
+
+		return OPEN_EMPTY;
 	}
 
-	return asm_file_name;
+	return OPEN_TRANSFER;
+}
+
+void queue_transfer(FileBatch *batch, uint32_t index)
+{
+	FileRequest *request = batch->requests + index;
+
+	size_t length = request->size - request->done;
+	if (length > BATCH_MAX_TRANSFER)
+		length = BATCH_MAX_TRANSFER;
+
+	// Never fails, there are never more requests in flight than the ring has entries
+	uring_queue(batch->ring, request->is_write ? URING_WRITE : URING_READ, request->fd,
+	            request->buffer + request->done, length, request->done, index);
+	request->state = REQUEST_IN_FLIGHT;
+}
+
+// Waits for one request to make progress. Short transfers are queued again for the rest of the file.
+void finish_request(FileBatch *batch)
+{
+	uint64_t index;
+	int32_t result;
+	uring_complete(batch->ring, true, &index, &result);
+
+	FileRequest *request = batch->requests + index;
+	if (result <= 0) {
+		// A read returning 0 means the file got shorter after it was measured
+		fprintf(stderr, "error: %s: cannot %s file: %s\n", request->file_name, request->is_write ? "write" : "read",
+		        result < 0 ? strerror(-result) : "unexpected end of file");
+		exit(EXIT_FAILURE);
+	}
+
+	request->done += result;
+	if (request->done < request->size) {
+		queue_transfer(batch, index);
+		uring_submit(batch->ring);
+
+		return;
+	}
+
+	close(request->fd);
+	request->state = REQUEST_FINISHED;
+	--batch->in_flight;
+
+	if (request->is_write) {
+		mem_free(request->buffer);
+		request->buffer = NULL;
+	}
 }
 
 uint32_t get_extension_index(const char *file_name)
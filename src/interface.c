@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "interface.h"
+#include "mem.h"
+
+#define MIN_BUCKET_COUNT 8
+
+typedef struct interface {
+	const char *file;
+	const uint8_t *map;
+	size_t map_size;
+
+	const InterfaceHeader *header;
+	const InterfaceEntry *entries;
+	const uint32_t *buckets;
+	const char *strings;
+	size_t strings_size;
+} Interface;
+
+static uint32_t hash(const char *name, size_t length);
+static uint32_t align(uint32_t offset);
+static void invalid_interface(const char *file_name);
+static const char *checked_string(const Interface *interface, uint32_t offset, uint32_t length);
+
+void interface_write(const char *file_name, const InterfaceExport *exports, uint32_t export_count)
+{
+	uint32_t bucket_count = MIN_BUCKET_COUNT;
+	while (bucket_count < export_count * 2)
+		bucket_count *= 2;
+
+	size_t strings_size = 0;
+	for (uint32_t i = 0; i < export_count; ++i)
+		strings_size += exports[i].symbol->id_length + strlen(exports[i].type) + 2;
+
+	InterfaceHeader header = {
+		.magic = INTERFACE_MAGIC,
+		.version = INTERFACE_VERSION,
+		.byte_order = INTERFACE_BYTE_ORDER,
+		.entry_size = sizeof(InterfaceEntry),
+		.export_count = export_count,
+		.bucket_count = bucket_count,
+		.entries_offset = align(sizeof(InterfaceHeader)),
+	};
+	header.buckets_offset = align(header.entries_offset + export_count * sizeof(InterfaceEntry));
+	header.strings_offset = align(header.buckets_offset + bucket_count * sizeof(uint32_t));
+	header.file_size = align(header.strings_offset + strings_size);
+
+	uint8_t *buffer = mem_calloc(MEM_INTERFACE, header.file_size, 1);
+	memcpy(buffer, &header, sizeof(InterfaceHeader));
+
+	InterfaceEntry *entries = (InterfaceEntry *)(buffer + header.entries_offset);
+	uint32_t *buckets = (uint32_t *)(buffer + header.buckets_offset);
+	char *strings = (char *)(buffer + header.strings_offset);
+
+	uint32_t string_offset = 0;
+	for (uint32_t i = 0; i < export_count; ++i) {
+		const InterfaceExport *current = exports + i;
+		InterfaceEntry *entry = entries + i;
+
+		entry->name_offset = string_offset;
+		entry->name_length = current->symbol->id_length;
+		memcpy(strings + string_offset, current->symbol->id, entry->name_length);
+		string_offset += entry->name_length + 1;
+
+		entry->type_offset = string_offset;
+		entry->type_length = strlen(current->type);
+		memcpy(strings + string_offset, current->type, entry->type_length);
+		string_offset += entry->type_length + 1;
+
+		entry->offset = current->offset;
+		entry->hash = hash(current->symbol->id, current->symbol->id_length);
+
+		uint32_t *bucket = buckets + (entry->hash & (bucket_count - 1));
+		entry->next = *bucket;
+		*bucket = i + 1;
+	}
+
+	FILE *file = fopen(file_name, "wb");
+	if (file == NULL || fwrite(buffer, 1, header.file_size, file) != header.file_size) {
+		fprintf(stderr, "error: %s: cannot write file\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+
+	fclose(file);
+	mem_free(buffer);
+}
+
+Interface *interface_open(const char *file_name)
+{
+	int fd = open(file_name, O_RDONLY);
+	if (fd == -1) {
+		fprintf(stderr, "error: %s: cannot open file\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+
+	struct stat file_stat;
+	if (fstat(fd, &file_stat) == -1 || (size_t)file_stat.st_size < sizeof(InterfaceHeader))
+		invalid_interface(file_name);
+
+	void *map = mmap(NULL, file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		fprintf(stderr, "error: %s: cannot map file\n", file_name);
+		exit(EXIT_FAILURE);
+	}
+
+	Interface *interface = mem_alloc(MEM_INTERFACE, sizeof(Interface));
+	interface->file = file_name;
+	interface->map = map;
+	interface->map_size = file_stat.st_size;
+	interface->header = map;
+
+	// Only the layout is checked here, entries are checked as lookups reach them
+	const InterfaceHeader *header = interface->header;
+	if (header->magic != INTERFACE_MAGIC || header->version != INTERFACE_VERSION ||
+	    header->byte_order != INTERFACE_BYTE_ORDER || header->entry_size != sizeof(InterfaceEntry) ||
+	    header->file_size != interface->map_size ||
+	    header->bucket_count == 0 || (header->bucket_count & (header->bucket_count - 1)) != 0 ||
+	    header->entries_offset + (uint64_t)header->export_count * sizeof(InterfaceEntry) > header->buckets_offset ||
+	    header->buckets_offset + (uint64_t)header->bucket_count * sizeof(uint32_t) > header->strings_offset ||
+	    header->strings_offset > header->file_size)
+		invalid_interface(file_name);
+
+	interface->entries = (const InterfaceEntry *)(interface->map + header->entries_offset);
+	interface->buckets = (const uint32_t *)(interface->map + header->buckets_offset);
+	interface->strings = (const char *)(interface->map + header->strings_offset);
+	interface->strings_size = header->file_size - header->strings_offset;
+
+	return interface;
+}
+
+void interface_close(Interface *interface)
+{
+	munmap((void *)interface->map, interface->map_size);
+	mem_free(interface);
+}
+
+const InterfaceEntry *interface_lookup(const Interface *interface, const char *name, size_t length)
+{
+	uint32_t name_hash = hash(name, length);
+	uint32_t export_count = interface->header->export_count;
+	uint32_t index = interface->buckets[name_hash & (interface->header->bucket_count - 1)];
+
+	// A chain can't be longer than the number of entries, anything longer has a cycle
+	for (uint32_t steps = 0; index != 0; ++steps) {
+		if (index > export_count || steps == export_count)
+			invalid_interface(interface->file);
+
+		const InterfaceEntry *entry = interface->entries + index - 1;
+		if (entry->hash == name_hash && entry->name_length == length &&
+		    memcmp(checked_string(interface, entry->name_offset, entry->name_length), name, length) == 0)
+			return entry;
+
+		index = entry->next;
+	}
+
+	return NULL;
+}
+
+const char *interface_name(const Interface *interface, const InterfaceEntry *entry)
+{
+	return checked_string(interface, entry->name_offset, entry->name_length);
+}
+
+const char *interface_type(const Interface *interface, const InterfaceEntry *entry)
+{
+	return checked_string(interface, entry->type_offset, entry->type_length);
+}
+
+// FNV-1a, the hash is part of the file format so it must not change between versions
+static uint32_t hash(const char *name, size_t length)
+{
+	uint32_t value = 2166136261u;
+
+	for (size_t i = 0; i < length; ++i) {
+		value ^= (unsigned char)name[i];
+		value *= 16777619u;
+	}
+
+	return value;
+}
+
+static uint32_t align(uint32_t offset)
+{
+	return (offset + 7) & ~(uint32_t)7;
+}
+
+// Returns the string at offset if it and its null terminator lie inside the string block
+static const char *checked_string(const Interface *interface, uint32_t offset, uint32_t length)
+{
+	if ((uint64_t)offset + length >= interface->strings_size || interface->strings[offset + length] != '\0')
+		invalid_interface(interface->file);
+
+	return interface->strings + offset;
+}
+
+static void invalid_interface(const char *file_name)
+{
+	fprintf(stderr, "error: %s: invalid module interface file\n", file_name);
+	exit(EXIT_FAILURE);
+}
@@ -1,26 +1,46 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 
 #include "keac.h"
-#include "file.h"
 #include "lexer.h"
 #include "symbol_table.h"
+#include "utf8.h"
+#include "mem.h"
 
-char *keac_compile(const char *file_name)
+char *keac_compile(const char *file_name, const char *src)
 {
 	SymbolTable *table = st_create(8);
-
-	char *src = file_read(file_name);
-
-	Lexer *lexer = lexer_create(src, file_name, table);
+	SymbolTable *literals = st_create(8);
+
+	// Validating the whole buffer once lets the lexer decode UTF-8 without any further checks
+	size_t src_length = strlen(src);
+	size_t invalid_index = utf8_validate(src, src_length);
+	if (invalid_index != src_length) {
+		uint64_t line = 1, column = 1;
+		for (size_t i = 0; i < invalid_index; ++i) {
+			if (src[i] == '\n') {
+				++line;
+				column = 1;
+			}
+			else if (((unsigned char)src[i] & 0xC0) != 0x80) {
+				++column;
+			}
+		}
+
+		keac_error(file_name, line, column, "invalid UTF-8 sequence\n");
+		exit(EXIT_FAILURE);
+	}
+
+	Lexer *lexer = lexer_create(src, file_name, table, literals);
 
 	while (lexer_next_token(lexer)->type != TOKEN_EOF);
 	putchar('\n');
-	free(src);
 	lexer_free(lexer);
 
 	st_free(table);
+	st_free(literals);
 
 	// After code generation
 	// char *assembly;
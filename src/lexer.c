@@ -10,14 +10,22 @@
 
 #include "keac.h"
 #include "lexer.h"
+#include "utf8.h"
+#include "scan.h"
+#include "mem.h"
 
 #define IDENTIFIER_LENGTH 255
 
 static void next_word(Lexer *this);
+static void skip_whitespace(Lexer *this);
+static void skip_block_comment(Lexer *this);
+static void lex_literal(Lexer *this, char quote);
+static uint32_t escape_length(const char *escape);
+static size_t decode_literal(const char *src, size_t length, char *dest);
 static bool is_repeatable(char c);
-static bool is_identifier_part(char c);
 
 static void identify_token(Lexer *this);
+static bool is_identifier(const char *lexeme);
 
 static void regex_compile(regex_t *dest, const char *src, int cflags);
 static bool regex_match(const char *src, regex_t *regex);
@@ -26,6 +34,7 @@ static void add_token(Lexer *this, TokenType type, uint64_t line);
 
 typedef struct lexer {
 	SymbolTable *table;
+	SymbolTable *literals; // String and character literals, kept apart from identifiers
 
 	const char *file;
 	const char *src;
@@ -35,17 +44,20 @@ typedef struct lexer {
 	uint64_t line, column;
 
 	char lexeme[IDENTIFIER_LENGTH + 1]; // + 1 for the null character
-	regex_t valid_int_reg, invalid_int_reg, identifier_reg;
+	const char *literal; // Contents of the last string or character literal, they can be longer than an identifier
+	size_t literal_length;
+	regex_t valid_int_reg, invalid_int_reg;
 
 	Token *token;
 } Lexer;
 
 
-Lexer *lexer_create(const char *src, const char *file_name, SymbolTable *table)
+Lexer *lexer_create(const char *src, const char *file_name, SymbolTable *table, SymbolTable *literals)
 {
-	Lexer *this = malloc(sizeof(Lexer));
+	Lexer *this = mem_alloc(MEM_LEXER, sizeof(Lexer));
 
 	this->table = table;
+	this->literals = literals;
 
 	this->file = file_name;
 	this->src = src;
@@ -55,12 +67,11 @@ Lexer *lexer_create(const char *src, const char *file_name, SymbolTable *table)
 	this->line = 1;
 	this->column = 0;
 
-	this->token = malloc(sizeof(Token));
+	this->token = mem_alloc(MEM_LEXER, sizeof(Token));
 
 	// Compiling the regex that will be used before lexing to improve performance and reduce memory usage
 	regex_compile(&this->valid_int_reg, "^[0-9]{1,20}$", REG_EXTENDED);
 	regex_compile(&this->invalid_int_reg, "^[0-9]{1,20}.*$", 0);
-	regex_compile(&this->identifier_reg, "^[A-Za-z_$][A-Za-z_$0-9]{0,254}$", REG_EXTENDED);
 
 	return this;
 }
@@ -69,13 +80,12 @@ void lexer_free(Lexer *this)
 {
 	pcre2_regfree(&this->valid_int_reg);
 	pcre2_regfree(&this->invalid_int_reg);
-	pcre2_regfree(&this->identifier_reg);
 
 	add_token(this, TOKEN_EOF, 0);
 
-	free(this->token);
+	mem_free(this->token);
 
-	free(this);
+	mem_free(this);
 }
 
 Token *lexer_next_token(Lexer *this)
@@ -93,36 +103,47 @@ void next_word(Lexer *this)
 
 	char current;
 
-	// Skip whitespace
-	while (isspace((current = this->src[this->index]))) {
-		if (current == '\n') {
-			++this->line;
-			this->column = 0;
+	skip_whitespace(this);
 
-			putchar('\n');
-		}
-		else if (current == '\t') {
-			putchar('\t');
+	for (uint32_t lexeme_index = 0; !isspace((unsigned char)(current = this->src[this->index])); ++lexeme_index) {
+		++this->column;
+
+		if (current == 0)
+			return;
+
+		if (lexeme_index == 0 && (current == '"' || current == '\'')) {
+			lex_literal(this, current);
+			return;
 		}
-		++this->index;
-	}
 
-	for (uint32_t lexeme_index = 0; !isspace((current = this->src[this->index])); ++lexeme_index) {
-		++this->column;
+		// The source was validated as UTF-8 when it was loaded, so multi-byte sequences can be decoded blindly.
+		// Plain ASCII never leaves the single-byte path.
+		uint32_t code_point = (unsigned char)current;
+		uint32_t length = 1;
+		if (code_point >= 0x80)
+			length = utf8_decode(this->src + this->index, &code_point);
 
-		if (lexeme_index == IDENTIFIER_LENGTH - 1) {
+		if (lexeme_index + length > IDENTIFIER_LENGTH - 1) {
 			keac_error(this->file, this->line, this->column, "identifier length exceeds limit of %d\n", IDENTIFIER_LENGTH);
 			exit(EXIT_FAILURE);
 		}
 
-		if (current == 0)
-			return;
-
-		if (is_identifier_part(current)) {
-			this->lexeme[lexeme_index] = current;
-			++this->index;
+		if (utf8_is_identifier_part(code_point)) {
+			memcpy(this->lexeme + lexeme_index, this->src + this->index, length);
+			lexeme_index += length - 1;
+			this->index += length;
 			continue;
-		} 
+		}
+
+		if (length > 1) {
+			// Not part of an identifier and not an operator either, keep the whole character for the error message
+			if (lexeme_index == 0) {
+				memcpy(this->lexeme, this->src + this->index, length);
+				this->index += length;
+			}
+
+			return;
+		}
 
 		if (lexeme_index == 0) {
 			this->lexeme[lexeme_index++] = current;
@@ -130,7 +151,7 @@ void next_word(Lexer *this)
 			if (is_repeatable(current)) {
 				++this->index;
 				char current_peek = this->src[this->index++];
-				if (!isspace(current_peek)) {
+				if (!isspace((unsigned char)current_peek)) {
 					if (current_peek == 0)
 						return;
 
@@ -196,12 +217,188 @@ void next_word(Lexer *this)
 	++this->index;
 }
 
-bool is_identifier_part(char c)
+// Skips whitespace and comments
+void skip_whitespace(Lexer *this)
 {
-	if (isalnum(c) || c == '_' || c == '$')
-		return true;
-	else
-		return false;
+	while (1) {
+		char current = this->src[this->index];
+
+		if (isspace((unsigned char)current)) {
+			if (current == '\n') {
+				++this->line;
+				this->column = 0;
+
+				putchar('\n');
+			}
+			else if (current == '\t') {
+				putchar('\t');
+			}
+			++this->index;
+		}
+		else if (current == '/' && this->src[this->index + 1] == '/') {
+			// The newline is left for the whitespace branch
+			const char *end = memchr(this->src + this->index, '\n', this->src_length - this->index);
+			this->index = end == NULL ? this->src_length : (size_t)(end - this->src);
+		}
+		else if (current == '/' && this->src[this->index + 1] == '*') {
+			skip_block_comment(this);
+		}
+		else {
+			return;
+		}
+	}
+}
+
+void skip_block_comment(Lexer *this)
+{
+	uint64_t start_line = this->line, start_column = this->column + 1;
+
+	this->index += 2;
+	this->column += 2;
+
+	while (1) {
+		size_t offset = scan_until(this->src + this->index, this->src_length - this->index, '*', '\n', '\n');
+		this->index += offset;
+		this->column += offset;
+
+		if (this->index == this->src_length) {
+			keac_error(this->file, start_line, start_column, "unterminated block comment\n");
+			exit(EXIT_FAILURE);
+		}
+
+		if (this->src[this->index] == '\n') {
+			++this->line;
+			this->column = 0;
+			++this->index;
+		}
+		else if (this->src[this->index + 1] == '/') {
+			this->index += 2;
+			this->column += 2;
+			return;
+		}
+		else {
+			++this->index;
+			++this->column;
+		}
+	}
+}
+
+// Lexes a string or character literal starting at the opening quote. Only the terminator and escape positions are
+// searched for, the escapes themselves are decoded later by lexer_literal_value.
+void lex_literal(Lexer *this, char quote)
+{
+	const char *kind = quote == '"' ? "string" : "character";
+	uint64_t start_column = this->column;
+
+	size_t start = ++this->index;
+	while (1) {
+		size_t offset = scan_until(this->src + this->index, this->src_length - this->index, quote, '\\', '\n');
+		this->index += offset;
+
+		if (this->index == this->src_length || this->src[this->index] == '\n') {
+			keac_error(this->file, this->line, start_column, "unterminated %s literal\n", kind);
+			exit(EXIT_FAILURE);
+		}
+
+		if (this->src[this->index] == quote)
+			break;
+
+		uint32_t length = escape_length(this->src + this->index);
+		if (length == 0) {
+			keac_error(this->file, this->line, start_column + this->index - start + 1, "invalid escape sequence in %s literal\n", kind);
+			exit(EXIT_FAILURE);
+		}
+		this->index += length;
+	}
+
+	this->literal = this->src + start;
+	this->literal_length = this->index - start;
+	this->lexeme[0] = quote;
+
+	// Skip the closing quote
+	++this->index;
+	this->column += this->literal_length + 1;
+
+	if (quote == '\'') {
+		uint32_t code_point, length = 0;
+		if (this->literal_length != 0)
+			length = this->literal[0] == '\\' ? escape_length(this->literal) : utf8_decode(this->literal, &code_point);
+
+		if (length == 0 || length != this->literal_length) {
+			keac_error(this->file, this->line, start_column, "character literal must contain exactly one character\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+// Returns the length of the escape sequence starting at the backslash or 0 if it is invalid
+uint32_t escape_length(const char *escape)
+{
+	switch (escape[1]) {
+		case 'n': case 't': case 'r': case '0': case '\\': case '\'': case '"':
+			return 2;
+		case 'x':
+			if (isxdigit((unsigned char)escape[2]) && isxdigit((unsigned char)escape[3]))
+				return 4;
+			return 0;
+		default:
+			return 0;
+	}
+}
+
+// Decodes the escape sequences of a validated literal into dest, which must be able to hold length bytes
+size_t decode_literal(const char *src, size_t length, char *dest)
+{
+	const char *end = src + length;
+	length = 0;
+
+	while (src < end) {
+		const char *escape = memchr(src, '\\', end - src);
+		if (escape == NULL)
+			escape = end;
+
+		memcpy(dest + length, src, escape - src);
+		length += escape - src;
+		if (escape == end)
+			break;
+
+		switch (escape[1]) {
+			case 'n': dest[length++] = '\n'; break;
+			case 't': dest[length++] = '\t'; break;
+			case 'r': dest[length++] = '\r'; break;
+			case '0': dest[length++] = '\0'; break;
+			case 'x': {
+				char digits[3] = { escape[2], escape[3], 0 };
+				dest[length++] = (char)strtol(digits, NULL, 16);
+				break;
+			}
+			default:  dest[length++] = escape[1]; break;
+		}
+
+		src = escape + escape_length(escape);
+	}
+
+	return length;
+}
+
+Symbol *lexer_literal_value(SymbolTable *literals, Symbol *literal)
+{
+	if (literal->literal_value != NULL)
+		return literal->literal_value;
+
+	if (memchr(literal->id, '\\', literal->id_length) == NULL) {
+		literal->literal_value = literal;
+	}
+	else {
+		// Decoding never makes a literal longer
+		char *decoded = mem_alloc(MEM_LEXER, literal->id_length);
+		size_t length = decode_literal(literal->id, literal->id_length, decoded);
+
+		literal->literal_value = st_intern(literals, decoded, length);
+		mem_free(decoded);
+	}
+
+	return literal->literal_value;
 }
 
 bool is_repeatable(char c)
@@ -216,6 +413,8 @@ bool is_repeatable(char c)
 void identify_token(Lexer *this)
 {
 	if (this->lexeme[0] == '(')                     add_token(this, TOKEN_LEFT_PAREN, this->line);
+	else if (this->lexeme[0] == '"')                add_token(this, TOKEN_STRING_LITERAL, this->line);
+	else if (this->lexeme[0] == '\'')               add_token(this, TOKEN_CHARACTER_LITERAL, this->line);
 	else if (this->lexeme[0] == ')')                add_token(this, TOKEN_RIGHT_PAREN, this->line);
 	else if (this->lexeme[0] == '[')                add_token(this, TOKEN_LEFT_BRACKET, this->line);
 	else if (this->lexeme[0] == ']')                add_token(this, TOKEN_RIGHT_BRACKET, this->line);
@@ -287,7 +486,7 @@ void identify_token(Lexer *this)
 		keac_error(this->file, this->line, this->column, "invalid integer literal: %s\n", this->lexeme);
 		exit(EXIT_FAILURE);
 	}
-	else if (regex_match(this->lexeme, &this->identifier_reg))
+	else if (is_identifier(this->lexeme))
 		add_token(this, TOKEN_IDENTIFIER, this->line);
 	else {
 		keac_error(this->file, this->line, this->column, "unknown lexeme: %s\n", this->lexeme);
@@ -296,15 +495,25 @@ void identify_token(Lexer *this)
 	}
 }
 
+// next_word only groups identifier characters together, so checking the first one is enough
+bool is_identifier(const char *lexeme)
+{
+	uint32_t code_point;
+	utf8_decode(lexeme, &code_point);
+
+	return utf8_is_identifier_start(code_point);
+}
+
 void add_token(Lexer *this, TokenType type, uint64_t line)
 {
 	this->token->type = type;
 
+	// Literals are interned as they are spelled, their escapes are only decoded once lexer_literal_value is called
 	Symbol *value = NULL;
-	if (type == TOKEN_IDENTIFIER || type == TOKEN_INT_LITERAL || type == TOKEN_STRING_LITERAL) {
-		if ((value = st_get_symbol(this->table, this->lexeme)) == NULL)
-			value = st_add_symbol(this->table, this->lexeme);
-	}
+	if (type == TOKEN_STRING_LITERAL || type == TOKEN_CHARACTER_LITERAL)
+		value = st_intern(this->literals, this->literal, this->literal_length);
+	else if (type == TOKEN_IDENTIFIER || type == TOKEN_INT_LITERAL)
+		value = st_intern(this->table, this->lexeme, strlen(this->lexeme));
 	this->token->value = value;
 
 	this->token->line = line;
@@ -1,8 +1,12 @@
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 // #include <stdlib.h>
 
 #include "keac.h"
-// #include "file.h"
+#include "mem.h"
+#include "file.h"
 
 int main(int argc, char **argv)
 {
@@ -11,15 +15,52 @@ int main(int argc, char **argv)
 		return 1;
 	}
 
+	bool mem_stats = false;
+	uint32_t file_count = 0;
+
+	// Every input is queued before compiling starts, so later files are read while earlier ones are compiled
+	FileBatch *batch = file_batch_create();
+
 	for (int i = 1; i < argc; ++i) {
-		keac_compile(argv[i]);
-		// char *assembly = keac_compile(argv[i]);
+		if (strncmp(argv[i], "--", 2) == 0) {
+			if (strcmp(argv[i], "--stats=mem") == 0) {
+				mem_stats = true;
+			}
+			else {
+				fprintf(stderr, "error: unrecognised option: %s\n", argv[i]);
+				return 1;
+			}
+			continue;
+		}
+
+		file_batch_read(batch, argv[i]);
+		++file_count;
+	}
+
+	if (file_count == 0) {
+		fprintf(stderr, "error: no input files\n");
+		return 1;
+	}
+
+	for (int i = 1, file = 0; i < argc; ++i) {
+		if (strncmp(argv[i], "--", 2) == 0)
+			continue;
+
+		char *src = file_batch_wait(batch, file++);
+		keac_compile(argv[i], src);
+		// char *assembly = keac_compile(argv[i], src);
 		// char *asm_file_name = file_asm_name(argv[i]);
 
-		// file_write(asm_file_name, assembly);
-		// free(assembly);
-		// free(asm_file_name);
+		// file_batch_write(batch, asm_file_name, assembly);
+		// mem_free(asm_file_name);
+		mem_free(src);
 	}
 
+	// Waits for the outputs that are still being written
+	file_batch_free(batch);
+
+	if (mem_stats)
+		mem_print_stats();
+
 	return 0;
 }
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "mem.h"
+
+// Stored in front of every allocation so that mem_free and mem_realloc know what to account for
+typedef union {
+	struct {
+		size_t size;
+		MemTag tag;
+	} info;
+	max_align_t align;
+} MemHeader;
+
+typedef struct {
+	size_t live, peak;
+	uint64_t allocations, reallocations;
+} MemStats;
+
+static MemStats stats[MEM_TAG_COUNT];
+static MemStats total;
+
+static const char *tag_names[MEM_TAG_COUNT] = {
+	[MEM_FILE]      = "file",
+	[MEM_LEXER]     = "lexer",
+	[MEM_SYMTAB]    = "symtab",
+	[MEM_SCOPE]     = "scope",
+	[MEM_INTERFACE] = "interface",
+	[MEM_VM]        = "vm",
+};
+
+static void *track(MemHeader *header, MemTag tag, size_t size);
+static void add_live(MemStats *tag_stats, size_t size);
+static void untrack(MemHeader *header);
+static void out_of_memory(void);
+
+void *mem_alloc(MemTag tag, size_t size)
+{
+	if (size > SIZE_MAX - sizeof(MemHeader))
+		out_of_memory();
+
+	return track(malloc(sizeof(MemHeader) + size), tag, size);
+}
+
+void *mem_calloc(MemTag tag, size_t count, size_t size)
+{
+	if (size != 0 && count > (SIZE_MAX - sizeof(MemHeader)) / size)
+		out_of_memory();
+
+	void *ptr = mem_alloc(tag, count * size);
+	memset(ptr, 0, count * size);
+
+	return ptr;
+}
+
+void *mem_realloc(MemTag tag, void *ptr, size_t size)
+{
+	if (ptr == NULL)
+		return mem_alloc(tag, size);
+
+	MemHeader *header = (MemHeader *)ptr - 1;
+	if (size > SIZE_MAX - sizeof(MemHeader))
+		out_of_memory();
+
+	untrack(header);
+	header = realloc(header, sizeof(MemHeader) + size);
+	if (header == NULL)
+		out_of_memory();
+
+	header->info.size = size;
+	header->info.tag = tag;
+
+	++stats[tag].reallocations;
+	++total.reallocations;
+	add_live(stats + tag, size);
+	add_live(&total, size);
+
+	return header + 1;
+}
+
+void mem_free(void *ptr)
+{
+	if (ptr == NULL)
+		return;
+
+	MemHeader *header = (MemHeader *)ptr - 1;
+	untrack(header);
+	free(header);
+}
+
+void mem_print_stats(void)
+{
+	fprintf(stderr, "%-10s %14s %14s %12s %14s\n", "subsystem", "live bytes", "peak bytes", "allocations", "reallocations");
+	for (int i = 0; i < MEM_TAG_COUNT; ++i) {
+		MemStats *tag_stats = stats + i;
+		fprintf(stderr, "%-10s %14zu %14zu %12lu %14lu\n", tag_names[i], tag_stats->live, tag_stats->peak,
+		        tag_stats->allocations, tag_stats->reallocations);
+	}
+	fprintf(stderr, "%-10s %14zu %14zu %12lu %14lu\n", "total", total.live, total.peak, total.allocations, total.reallocations);
+}
+
+static void *track(MemHeader *header, MemTag tag, size_t size)
+{
+	if (header == NULL)
+		out_of_memory();
+
+	header->info.size = size;
+	header->info.tag = tag;
+
+	++stats[tag].allocations;
+	++total.allocations;
+	add_live(stats + tag, size);
+	add_live(&total, size);
+
+	return header + 1;
+}
+
+static void add_live(MemStats *tag_stats, size_t size)
+{
+	tag_stats->live += size;
+	if (tag_stats->live > tag_stats->peak)
+		tag_stats->peak = tag_stats->live;
+}
+
+static void untrack(MemHeader *header)
+{
+	stats[header->info.tag].live -= header->info.size;
+	total.live -= header->info.size;
+}
+
+static void out_of_memory(void)
+{
+	fprintf(stderr, "internal error: out of memory\n");
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,33 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "scan.h"
+
+size_t scan_until(const char *src, size_t length, char a, char b, char c)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+	__m128i vector_a = _mm_set1_epi8(a);
+	__m128i vector_b = _mm_set1_epi8(b);
+	__m128i vector_c = _mm_set1_epi8(c);
+
+	for (; i + 16 <= length; i += 16) {
+		__m128i block = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i matches = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, vector_a), _mm_cmpeq_epi8(block, vector_b)),
+		                               _mm_cmpeq_epi8(block, vector_c));
+
+		int mask = _mm_movemask_epi8(matches);
+		if (mask != 0)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	for (; i < length; ++i) {
+		if (src[i] == a || src[i] == b || src[i] == c)
+			return i;
+	}
+
+	return length;
+}
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "scope.h"
+#include "mem.h"
+
+#define INITIAL_BINDING_CAPACITY 64
+#define INITIAL_MARKS_CAPACITY 16
+
+static void *grow(void *array, size_t *capacity, size_t element_size);
+
+ScopeStack *scope_create(void)
+{
+	ScopeStack *scopes = mem_alloc(MEM_SCOPE, sizeof(ScopeStack));
+
+	scopes->binding_count = 0;
+	scopes->binding_capacity = INITIAL_BINDING_CAPACITY;
+	scopes->bindings = mem_alloc(MEM_SCOPE, scopes->binding_capacity * sizeof(Binding));
+
+	scopes->depth = 0;
+	scopes->marks_capacity = INITIAL_MARKS_CAPACITY;
+	scopes->marks = mem_alloc(MEM_SCOPE, scopes->marks_capacity * sizeof(size_t));
+
+	return scopes;
+}
+
+void scope_free(ScopeStack *scopes)
+{
+	// Unlink every symbol so that the table can be reused by another scope stack
+	while (scopes->depth != 0)
+		scope_exit(scopes);
+	while (scopes->binding_count != 0) {
+		Binding *binding = scopes->bindings + --scopes->binding_count;
+		binding->symbol->binding = binding->shadowed;
+	}
+
+	mem_free(scopes->bindings);
+	mem_free(scopes->marks);
+	mem_free(scopes);
+}
+
+void scope_enter(ScopeStack *scopes)
+{
+	if (scopes->depth == scopes->marks_capacity)
+		scopes->marks = grow(scopes->marks, &scopes->marks_capacity, sizeof(size_t));
+
+	scopes->marks[scopes->depth++] = scopes->binding_count;
+}
+
+void scope_exit(ScopeStack *scopes)
+{
+	if (scopes->depth == 0) {
+		fprintf(stderr, "internal error: scope_exit called without a matching scope_enter\n");
+		exit(EXIT_FAILURE);
+	}
+
+	size_t mark = scopes->marks[--scopes->depth];
+	while (scopes->binding_count > mark) {
+		Binding *binding = scopes->bindings + --scopes->binding_count;
+		binding->symbol->binding = binding->shadowed;
+	}
+}
+
+Binding *scope_bind(ScopeStack *scopes, Symbol *symbol, void *value)
+{
+	Binding *current = scope_resolve(scopes, symbol);
+	if (current != NULL && current->depth == scopes->depth)
+		return NULL;
+
+	if (scopes->binding_count == scopes->binding_capacity)
+		scopes->bindings = grow(scopes->bindings, &scopes->binding_capacity, sizeof(Binding));
+
+	Binding *binding = scopes->bindings + scopes->binding_count++;
+	binding->symbol = symbol;
+	binding->value = value;
+	binding->depth = scopes->depth;
+	binding->shadowed = symbol->binding;
+
+	// Indices are stored off by one so that a zeroed symbol is unbound
+	symbol->binding = scopes->binding_count;
+
+	return binding;
+}
+
+Binding *scope_resolve(ScopeStack *scopes, const Symbol *symbol)
+{
+	if (symbol->binding == 0)
+		return NULL;
+
+	return scopes->bindings + symbol->binding - 1;
+}
+
+static void *grow(void *array, size_t *capacity, size_t element_size)
+{
+	*capacity *= 2;
+
+	return mem_realloc(MEM_SCOPE, array, *capacity * element_size);
+}
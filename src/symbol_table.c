@@ -3,16 +3,19 @@
 #include <string.h>
 
 #include "symbol_table.h"
+#include "mem.h"
 
-static unsigned int hash(const char *id, size_t table_size);
-// static void double_table_size(SymbolTable *table);
+static unsigned int hash(const char *id, size_t length, size_t table_size);
+static Symbol *find_symbol(SymbolTable *table, const char *value, size_t length);
+static Symbol *insert_symbol(SymbolTable *table, const char *value, size_t length);
+static void double_table_size(SymbolTable *table);
 
 SymbolTable *st_create(size_t initial_size)
 {
-	SymbolTable *table = malloc(sizeof(SymbolTable));
+	SymbolTable *table = mem_alloc(MEM_SYMTAB, sizeof(SymbolTable));
 
 	table->table_size = initial_size;
-	table->table = calloc(initial_size, sizeof(Symbol));
+	table->table = mem_calloc(MEM_SYMTAB, initial_size, sizeof(Symbol *));
 	table->entry_count = 0;
 
 	return table;
@@ -21,110 +24,71 @@ SymbolTable *st_create(size_t initial_size)
 void st_free(SymbolTable *table)
 {
 	for (int i = 0; i < table->table_size; ++i) {
-		Symbol *current_slot = table->table + i;
+		Symbol *temp = table->table[i];
 
-		free(current_slot->id);
+		while (temp != NULL) {
+			Symbol *next = temp->next;
 
-		Symbol *temp = current_slot->next;
-		if (temp == NULL)
-			continue;
-
-		Symbol *temp2;
-		while (1) {
-			free(temp->id);
-			temp2 = temp;
-
-			if (temp->next == NULL) {
-				free(temp);
-				break;
-			}
-			else {
-				temp = temp->next;
-				free(temp2);
-			}
+			mem_free(temp->id);
+			mem_free(temp);
+
+			temp = next;
 		}
 	}
 
-	free(table->table);
-	free(table);
+	mem_free(table->table);
+	mem_free(table);
 }
 
 Symbol *st_get_symbol(SymbolTable *table, const char *value)
 {
-	Symbol *temp = table->table + hash(value, table->table_size);
-	if (temp == NULL)
-		return NULL;
-
-	while (1) {
-		if (temp->id == NULL)
-			return NULL;
-		else if (strcmp(temp->id, value) == 0)
-			return temp;
-
-		if (temp->next == NULL)
-			return NULL;
-		else
-			temp = temp->next;
-	}
+	return find_symbol(table, value, strlen(value));
 }
 
 Symbol *st_add_symbol(SymbolTable *table, const char *value)
 {
-	// if (table->entry_count == table->table_size)
-	// 	double_table_size(table);
-
-	++table->entry_count;
-	size_t value_len = strlen(value);
-
-	char *id = calloc(value_len + 1, sizeof(char));
-	strcpy(id, value);
-
-	unsigned int slot = hash(value, table->table_size);
-	Symbol *current = table->table + slot;
-
-	if (current->id == NULL) {
-		current->id = id;
-		current->id_length = value_len;
-
-		return current;
-	}
-	else {
-		Symbol *temp = current;
-
-		while (temp->next != NULL)
-			temp = temp->next;
-		temp->next = calloc(1, sizeof(Symbol));
-		temp = temp->next;
+	return insert_symbol(table, value, strlen(value));
+}
 
-		temp->id = id;
-		temp->id_length = value_len;
+Symbol *st_intern(SymbolTable *table, const char *value, size_t length)
+{
+	Symbol *symbol = find_symbol(table, value, length);
+	if (symbol == NULL)
+		symbol = insert_symbol(table, value, length);
 
-		return temp;
-	}
+	return symbol;
 }
 
-void st_remove_symbol(SymbolTable *table, const char *value)
+bool st_remove_symbol(SymbolTable *table, const char *value)
 {
 	if (table->table_size == 0)
-		return;
+		return false;
 
-	--table->entry_count;
+	size_t value_len = strlen(value);
+	unsigned int slot = hash(value, value_len, table->table_size);
 
-	unsigned int slot = hash(value, table->table_size);
+	Symbol **link = table->table + slot;
+	while (*link != NULL) {
+		Symbol *temp = *link;
 
-	if (table->table[slot].id == NULL)
-		return;
+		if (temp->id_length == value_len && strcmp(temp->id, value) == 0) {
+			// A scope still refers to the symbol, the caller has to leave that scope before removing it
+			if (temp->binding != 0)
+				return false;
 
-	Symbol *temp = table->table + slot;
-	while (strcmp(temp->id, value) != 0)
-		temp = temp->next;
+			*link = temp->next;
+			--table->entry_count;
+
+			mem_free(temp->id);
+			mem_free(temp);
+
+			return true;
+		}
 
-	free(temp->id);
+		link = &temp->next;
+	}
 
-	if (temp->next == NULL)
-		memset(temp, 0, sizeof(Symbol));
-	else
-		memcpy(temp, temp->next, sizeof(Symbol));
+	return false;
 }
 
 void sb_print(SymbolTable *table)
@@ -132,33 +96,28 @@ void sb_print(SymbolTable *table)
 	for (int i = 0; i < table->table_size; ++i) {
 		printf("entry %d: ", i + 1);
 
-		Symbol *temp = table->table + i;
-		while (1) {
-			if (temp->id != NULL)
-				printf("%s", temp->id);
-			else {
-				printf("[empty]");
-				break;
-			}
+		Symbol *temp = table->table[i];
+		if (temp == NULL)
+			printf("[empty]");
 
-			if (temp->next == NULL)
-				break;
+		while (temp != NULL) {
+			printf("%s", temp->id);
 
-			temp = temp->next;
+			if (temp->next != NULL)
+				printf(" | ");
 
-			printf(" | ");
+			temp = temp->next;
 		}
 
 		putchar('\n');
 	}
 }
 
-static unsigned int hash(const char *id, size_t table_size)
+static unsigned int hash(const char *id, size_t length, size_t table_size)
 {
-	unsigned int length = strlen(id);
 	unsigned int value = 0;
 
-	for (int i = 0; i < length; ++i) {
+	for (size_t i = 0; i < length; ++i) {
 		value = value * 37 + id[i];
 	}
 	value = value % table_size;
@@ -166,15 +125,61 @@ static unsigned int hash(const char *id, size_t table_size)
 	return value;
 }
 
-// static void double_table_size(SymbolTable *table)
-// {
-// 	Symbol *old_table = table->table;
-// 	size_t old_table_size = table->table_size;
+static Symbol *find_symbol(SymbolTable *table, const char *value, size_t length)
+{
+	Symbol *temp = table->table[hash(value, length, table->table_size)];
+
+	while (temp != NULL) {
+		if (temp->id_length == length && memcmp(temp->id, value, length) == 0)
+			return temp;
+
+		temp = temp->next;
+	}
+
+	return NULL;
+}
+
+static Symbol *insert_symbol(SymbolTable *table, const char *value, size_t length)
+{
+	if (table->entry_count >= table->table_size)
+		double_table_size(table);
+
+	++table->entry_count;
+
+	char *id = mem_calloc(MEM_SYMTAB, length + 1, sizeof(char));
+	memcpy(id, value, length);
+
+	unsigned int slot = hash(value, length, table->table_size);
+
+	Symbol *symbol = mem_calloc(MEM_SYMTAB, 1, sizeof(Symbol));
+	symbol->id = id;
+	symbol->id_length = length;
+
+	symbol->next = table->table[slot];
+	table->table[slot] = symbol;
+
+	return symbol;
+}
+
+static void double_table_size(SymbolTable *table)
+{
+	Symbol **old_table = table->table;
+	size_t old_table_size = table->table_size;
+
+	table->table_size = old_table_size != 0 ? old_table_size * 2 : 1;
+	table->table = mem_calloc(MEM_SYMTAB, table->table_size, sizeof(Symbol *));
 
-// 	table->table = calloc((table->table_size *= 2), sizeof(Symbol));
+	for (size_t i = 0; i < old_table_size; ++i) {
+		Symbol *temp = old_table[i];
+		while (temp != NULL) {
+			Symbol *next = temp->next;
+			unsigned int slot = hash(temp->id, temp->id_length, table->table_size);
 
-// 	for (int i = 0; i < old_table_size; ++i)
-// 		table->table[hash(old_table[i].id, table->table_size)] = old_table[i];
+			temp->next = table->table[slot];
+			table->table[slot] = temp;
+			temp = next;
+		}
+	}
 
-// 	free(old_table);
-// }
+	mem_free(old_table);
+}
@@ -0,0 +1,201 @@
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uring.h"
+#include "mem.h"
+
+// __has_include can only be used once it is known to exist, compilers without it just get the stub
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define URING_SUPPORTED
+#endif
+#endif
+
+#ifdef URING_SUPPORTED
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+typedef struct uring {
+	int fd;
+	uint32_t entries;
+	uint32_t queued; // Written to the submission queue but not submitted yet
+
+	void *sq_map, *cq_map;
+	size_t sq_map_size, cq_map_size;
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	uint32_t *sq_head, *sq_tail, *sq_mask, *sq_array;
+	uint32_t *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_cqe *cqes;
+} Uring;
+
+static int uring_enter(Uring *ring, uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+
+Uring *uring_create(uint32_t entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+
+	int fd = syscall(__NR_io_uring_setup, entries, &params);
+	if (fd < 0)
+		return NULL;
+
+	// IORING_OP_READ and IORING_OP_WRITE came with 5.6, the same release as IORING_FEAT_RW_CUR_POS
+	if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+		close(fd);
+		return NULL;
+	}
+
+	Uring *ring = mem_calloc(MEM_FILE, 1, sizeof(Uring));
+	ring->fd = fd;
+	ring->entries = params.sq_entries;
+
+	ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+	ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+	if (params.features & IORING_FEAT_SINGLE_MMAP) {
+		if (ring->cq_map_size > ring->sq_map_size)
+			ring->sq_map_size = ring->cq_map_size;
+		ring->cq_map_size = ring->sq_map_size;
+	}
+
+	ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring->cq_map = ring->sq_map;
+	else
+		ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+
+	ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+	if (ring->sq_map == MAP_FAILED || ring->cq_map == MAP_FAILED || ring->sqes == MAP_FAILED) {
+		uring_free(ring);
+		return NULL;
+	}
+
+	uint8_t *sq = ring->sq_map, *cq = ring->cq_map;
+	ring->sq_head = (uint32_t *)(sq + params.sq_off.head);
+	ring->sq_tail = (uint32_t *)(sq + params.sq_off.tail);
+	ring->sq_mask = (uint32_t *)(sq + params.sq_off.ring_mask);
+	ring->sq_array = (uint32_t *)(sq + params.sq_off.array);
+	ring->cq_head = (uint32_t *)(cq + params.cq_off.head);
+	ring->cq_tail = (uint32_t *)(cq + params.cq_off.tail);
+	ring->cq_mask = (uint32_t *)(cq + params.cq_off.ring_mask);
+	ring->cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+	return ring;
+}
+
+void uring_free(Uring *ring)
+{
+	if (ring->sqes != NULL && ring->sqes != MAP_FAILED)
+		munmap(ring->sqes, ring->sqes_size);
+	if (ring->cq_map != NULL && ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+		munmap(ring->cq_map, ring->cq_map_size);
+	if (ring->sq_map != NULL && ring->sq_map != MAP_FAILED)
+		munmap(ring->sq_map, ring->sq_map_size);
+
+	close(ring->fd);
+	mem_free(ring);
+}
+
+bool uring_queue(Uring *ring, UringOperation operation, int fd, void *buffer, uint32_t length, uint64_t offset, uint64_t user_data)
+{
+	uint32_t tail = *ring->sq_tail;
+	if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) == ring->entries)
+		return false;
+
+	uint32_t index = tail & *ring->sq_mask;
+	struct io_uring_sqe *sqe = ring->sqes + index;
+	memset(sqe, 0, sizeof(*sqe));
+
+	sqe->opcode = operation == URING_READ ? IORING_OP_READ : IORING_OP_WRITE;
+	sqe->fd = fd;
+	sqe->addr = (uint64_t)(uintptr_t)buffer;
+	sqe->len = length;
+	sqe->off = offset;
+	sqe->user_data = user_data;
+
+	ring->sq_array[index] = index;
+	__atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++ring->queued;
+
+	return true;
+}
+
+void uring_submit(Uring *ring)
+{
+	while (ring->queued != 0) {
+		int submitted = uring_enter(ring, ring->queued, 0, 0);
+		ring->queued -= submitted;
+	}
+}
+
+bool uring_complete(Uring *ring, bool wait, uint64_t *user_data, int32_t *result)
+{
+	uint32_t head = *ring->cq_head;
+
+	while (head == __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE)) {
+		if (!wait)
+			return false;
+
+		// Anything still queued is submitted in the same call
+		uint32_t queued = ring->queued;
+		ring->queued -= uring_enter(ring, queued, 1, IORING_ENTER_GETEVENTS);
+	}
+
+	struct io_uring_cqe *cqe = ring->cqes + (head & *ring->cq_mask);
+	*user_data = cqe->user_data;
+	*result = cqe->res;
+
+	__atomic_store_n(ring->cq_head, head + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+static int uring_enter(Uring *ring, uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+{
+	int result;
+	while ((result = syscall(__NR_io_uring_enter, ring->fd, to_submit, min_complete, flags, NULL, 0)) < 0) {
+		if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+			fprintf(stderr, "internal error: io_uring_enter failed: %s\n", strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	return result;
+}
+
+#else
+
+Uring *uring_create(uint32_t entries)
+{
+	return NULL;
+}
+
+void uring_free(Uring *ring)
+{
+}
+
+bool uring_queue(Uring *ring, UringOperation operation, int fd, void *buffer, uint32_t length, uint64_t offset, uint64_t user_data)
+{
+	return false;
+}
+
+void uring_submit(Uring *ring)
+{
+}
+
+bool uring_complete(Uring *ring, bool wait, uint64_t *user_data, int32_t *result)
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,134 @@
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "utf8.h"
+#include "xid_tables.h"
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+static bool in_ranges(uint32_t code_point, const uint32_t ranges[][2], size_t range_count);
+
+size_t utf8_validate(const char *src, size_t length)
+{
+	const unsigned char *bytes = (const unsigned char *)src;
+	size_t i = 0;
+
+	while (i < length) {
+#ifdef __SSE2__
+		// ASCII fast path: skip whole blocks that have no byte with the high bit set
+		while (i + 16 <= length) {
+			__m128i block = _mm_loadu_si128((const __m128i *)(bytes + i));
+			int mask = _mm_movemask_epi8(block);
+			if (mask != 0) {
+				i += __builtin_ctz(mask);
+				break;
+			}
+			i += 16;
+		}
+		if (i >= length)
+			break;
+#endif
+
+		unsigned char c = bytes[i];
+		if (c < 0x80) {
+			++i;
+			continue;
+		}
+
+		// Lead bytes C0, C1 and F5..FF can never appear, and the second byte range is narrowed
+		// for E0 (overlong), ED (surrogates), F0 (overlong) and F4 (above U+10FFFF)
+		size_t sequence_length;
+		unsigned char low = 0x80, high = 0xBF;
+		if (c >= 0xC2 && c <= 0xDF)
+			sequence_length = 2;
+		else if (c >= 0xE0 && c <= 0xEF) {
+			sequence_length = 3;
+			if (c == 0xE0)
+				low = 0xA0;
+			else if (c == 0xED)
+				high = 0x9F;
+		}
+		else if (c >= 0xF0 && c <= 0xF4) {
+			sequence_length = 4;
+			if (c == 0xF0)
+				low = 0x90;
+			else if (c == 0xF4)
+				high = 0x8F;
+		}
+		else
+			return i;
+
+		if (length - i < sequence_length)
+			return i;
+		if (bytes[i + 1] < low || bytes[i + 1] > high)
+			return i;
+		for (size_t j = 2; j < sequence_length; ++j) {
+			if ((bytes[i + j] & 0xC0) != 0x80)
+				return i;
+		}
+
+		i += sequence_length;
+	}
+
+	return length;
+}
+
+uint32_t utf8_decode(const char *src, uint32_t *code_point)
+{
+	const unsigned char *bytes = (const unsigned char *)src;
+
+	if (bytes[0] < 0x80) {
+		*code_point = bytes[0];
+		return 1;
+	}
+	else if (bytes[0] < 0xE0) {
+		*code_point = ((uint32_t)(bytes[0] & 0x1F) << 6) | (bytes[1] & 0x3F);
+		return 2;
+	}
+	else if (bytes[0] < 0xF0) {
+		*code_point = ((uint32_t)(bytes[0] & 0x0F) << 12) | ((uint32_t)(bytes[1] & 0x3F) << 6) | (bytes[2] & 0x3F);
+		return 3;
+	}
+	else {
+		*code_point = ((uint32_t)(bytes[0] & 0x07) << 18) | ((uint32_t)(bytes[1] & 0x3F) << 12) |
+		              ((uint32_t)(bytes[2] & 0x3F) << 6) | (bytes[3] & 0x3F);
+		return 4;
+	}
+}
+
+bool utf8_is_identifier_start(uint32_t code_point)
+{
+	if (code_point < 0x80)
+		return (code_point >= 'a' && code_point <= 'z') || (code_point >= 'A' && code_point <= 'Z') ||
+		       code_point == '_' || code_point == '$';
+
+	return in_ranges(code_point, xid_start_ranges, ARRAY_LENGTH(xid_start_ranges));
+}
+
+bool utf8_is_identifier_part(uint32_t code_point)
+{
+	if (code_point < 0x80)
+		return (code_point >= 'a' && code_point <= 'z') || (code_point >= 'A' && code_point <= 'Z') ||
+		       (code_point >= '0' && code_point <= '9') || code_point == '_' || code_point == '$';
+
+	return in_ranges(code_point, xid_continue_ranges, ARRAY_LENGTH(xid_continue_ranges));
+}
+
+static bool in_ranges(uint32_t code_point, const uint32_t ranges[][2], size_t range_count)
+{
+	size_t low = 0, high = range_count;
+
+	while (low < high) {
+		size_t middle = low + (high - low) / 2;
+
+		if (code_point < ranges[middle][0])
+			high = middle;
+		else if (code_point > ranges[middle][1])
+			low = middle + 1;
+		else
+			return true;
+	}
+
+	return false;
+}
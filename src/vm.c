@@ -0,0 +1,226 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "vm.h"
+#include "mem.h"
+
+#define INITIAL_CODE_CAPACITY 64
+#define INITIAL_CONSTANT_CAPACITY 16
+
+// GCC and Clang can jump straight from one instruction handler to the next (computed goto), which gives the branch
+// predictor one indirect jump per handler instead of a single shared one. Other compilers get a plain switch.
+// Defining VM_SWITCH_DISPATCH forces the switch, test/vm_bench.c uses it to compare the two.
+#if defined(__GNUC__) && !defined(VM_SWITCH_DISPATCH)
+#define VM_THREADED
+#endif
+
+static void validate(const Chunk *chunk);
+static void runtime_error(const char *message);
+
+Chunk *vm_chunk_create(void)
+{
+	Chunk *chunk = mem_alloc(MEM_VM, sizeof(Chunk));
+
+	chunk->code_count = 0;
+	chunk->code_capacity = INITIAL_CODE_CAPACITY;
+	chunk->code = mem_alloc(MEM_VM, chunk->code_capacity * sizeof(Instruction));
+
+	chunk->constant_count = 0;
+	chunk->constant_capacity = INITIAL_CONSTANT_CAPACITY;
+	chunk->constants = mem_alloc(MEM_VM, chunk->constant_capacity * sizeof(int64_t));
+
+	return chunk;
+}
+
+void vm_chunk_free(Chunk *chunk)
+{
+	mem_free(chunk->code);
+	mem_free(chunk->constants);
+	mem_free(chunk);
+}
+
+size_t vm_emit(Chunk *chunk, Opcode opcode, uint8_t a, uint8_t b, uint8_t c, int32_t operand)
+{
+	if (chunk->code_count == chunk->code_capacity) {
+		chunk->code_capacity *= 2;
+		chunk->code = mem_realloc(MEM_VM, chunk->code, chunk->code_capacity * sizeof(Instruction));
+	}
+
+	Instruction *instruction = chunk->code + chunk->code_count;
+	instruction->opcode = opcode;
+	instruction->a = a;
+	instruction->b = b;
+	instruction->c = c;
+	instruction->operand = operand;
+
+	return chunk->code_count++;
+}
+
+uint32_t vm_add_constant(Chunk *chunk, int64_t value)
+{
+	if (chunk->constant_count == chunk->constant_capacity) {
+		chunk->constant_capacity *= 2;
+		chunk->constants = mem_realloc(MEM_VM, chunk->constants, chunk->constant_capacity * sizeof(int64_t));
+	}
+
+	chunk->constants[chunk->constant_count] = value;
+
+	return chunk->constant_count++;
+}
+
+#ifdef VM_THREADED
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#define CASE(opcode) label_##opcode:
+#define DISPATCH()   goto *dispatch_table[ip->opcode]
+#else
+#define CASE(opcode) case opcode:
+#define DISPATCH()   continue
+#endif
+
+#define NEXT() ++ip; DISPATCH()
+
+#define BINARY(operator) R[ip->a] = R[ip->b] operator R[ip->c]; NEXT()
+// Kea integers wrap around, so arithmetic that can overflow is done unsigned
+#define WRAPPING(operator) R[ip->a] = (int64_t)((uint64_t)R[ip->b] operator (uint64_t)R[ip->c]); NEXT()
+
+int64_t vm_run(const Chunk *chunk)
+{
+	int64_t R[VM_REGISTER_COUNT] = { 0 };
+	const Instruction *ip = chunk->code;
+	const int64_t *constants = chunk->constants;
+
+	// Handlers trust opcodes, constant indices and jump targets, so they are all checked once up front
+	validate(chunk);
+
+#ifdef VM_THREADED
+	static const void *dispatch_table[OP_COUNT] = {
+		[OP_LOAD_CONST]     = &&label_OP_LOAD_CONST,
+		[OP_MOVE]           = &&label_OP_MOVE,
+		[OP_ADD]            = &&label_OP_ADD,
+		[OP_SUB]            = &&label_OP_SUB,
+		[OP_MUL]            = &&label_OP_MUL,
+		[OP_DIV]            = &&label_OP_DIV,
+		[OP_MOD]            = &&label_OP_MOD,
+		[OP_AND]            = &&label_OP_AND,
+		[OP_OR]             = &&label_OP_OR,
+		[OP_XOR]            = &&label_OP_XOR,
+		[OP_SHL]            = &&label_OP_SHL,
+		[OP_SHR]            = &&label_OP_SHR,
+		[OP_EQUAL]          = &&label_OP_EQUAL,
+		[OP_NOT_EQUAL]      = &&label_OP_NOT_EQUAL,
+		[OP_LESS_THAN]      = &&label_OP_LESS_THAN,
+		[OP_LESS_EQUAL]     = &&label_OP_LESS_EQUAL,
+		[OP_INCREMENT]      = &&label_OP_INCREMENT,
+		[OP_DECREMENT]      = &&label_OP_DECREMENT,
+		[OP_JUMP]           = &&label_OP_JUMP,
+		[OP_JUMP_IF_FALSE]  = &&label_OP_JUMP_IF_FALSE,
+		[OP_JUMP_IF_TRUE]   = &&label_OP_JUMP_IF_TRUE,
+		[OP_LOOP_INC_LT]    = &&label_OP_LOOP_INC_LT,
+		[OP_JUMP_IF_NOT_LT] = &&label_OP_JUMP_IF_NOT_LT,
+		[OP_JUMP_IF_NOT_LE] = &&label_OP_JUMP_IF_NOT_LE,
+		[OP_RETURN]         = &&label_OP_RETURN,
+	};
+
+	DISPATCH();
+#else
+	for (;;) switch (ip->opcode) {
+#endif
+
+	CASE(OP_LOAD_CONST)     R[ip->a] = constants[ip->operand]; NEXT();
+	CASE(OP_MOVE)           R[ip->a] = R[ip->b]; NEXT();
+	CASE(OP_ADD)            WRAPPING(+);
+	CASE(OP_SUB)            WRAPPING(-);
+	CASE(OP_MUL)            WRAPPING(*);
+	CASE(OP_DIV)
+		if (R[ip->c] == 0)
+			runtime_error("division by zero");
+		if (R[ip->c] == -1) { // INT64_MIN / -1 overflows
+			R[ip->a] = (int64_t)(0 - (uint64_t)R[ip->b]);
+			NEXT();
+		}
+		BINARY(/);
+	CASE(OP_MOD)
+		if (R[ip->c] == 0)
+			runtime_error("division by zero");
+		if (R[ip->c] == -1) {
+			R[ip->a] = 0;
+			NEXT();
+		}
+		BINARY(%);
+	CASE(OP_AND)            BINARY(&);
+	CASE(OP_OR)             BINARY(|);
+	CASE(OP_XOR)            BINARY(^);
+	CASE(OP_SHL)            R[ip->a] = (int64_t)((uint64_t)R[ip->b] << (R[ip->c] & 63)); NEXT();
+	CASE(OP_SHR)            R[ip->a] = R[ip->b] >> (R[ip->c] & 63); NEXT();
+	CASE(OP_EQUAL)          BINARY(==);
+	CASE(OP_NOT_EQUAL)      BINARY(!=);
+	CASE(OP_LESS_THAN)      BINARY(<);
+	CASE(OP_LESS_EQUAL)     BINARY(<=);
+	CASE(OP_INCREMENT)      R[ip->a] = (int64_t)((uint64_t)R[ip->a] + 1); NEXT();
+	CASE(OP_DECREMENT)      R[ip->a] = (int64_t)((uint64_t)R[ip->a] - 1); NEXT();
+	CASE(OP_JUMP)           ip += ip->operand; DISPATCH();
+	CASE(OP_JUMP_IF_FALSE)  ip += R[ip->a] ? 1 : ip->operand; DISPATCH();
+	CASE(OP_JUMP_IF_TRUE)   ip += R[ip->a] ? ip->operand : 1; DISPATCH();
+	CASE(OP_LOOP_INC_LT)
+		R[ip->a] = (int64_t)((uint64_t)R[ip->a] + 1);
+		ip += R[ip->a] < R[ip->b] ? ip->operand : 1;
+		DISPATCH();
+	CASE(OP_JUMP_IF_NOT_LT) ip += R[ip->a] < R[ip->b] ? 1 : ip->operand; DISPATCH();
+	CASE(OP_JUMP_IF_NOT_LE) ip += R[ip->a] <= R[ip->b] ? 1 : ip->operand; DISPATCH();
+	CASE(OP_RETURN)         return R[ip->a];
+
+#ifndef VM_THREADED
+		default:
+			runtime_error("invalid opcode");
+	}
+#endif
+
+	return 0;
+}
+
+#ifdef VM_THREADED
+#pragma GCC diagnostic pop
+#endif
+
+static void validate(const Chunk *chunk)
+{
+	// The last instruction must not fall through, otherwise execution would run past the end of the code
+	if (chunk->code_count == 0)
+		runtime_error("empty chunk");
+	uint8_t last = chunk->code[chunk->code_count - 1].opcode;
+	if (last != OP_RETURN && last != OP_JUMP)
+		runtime_error("chunk doesn't end with a return or jump");
+
+	for (size_t i = 0; i < chunk->code_count; ++i) {
+		const Instruction *instruction = chunk->code + i;
+
+		switch (instruction->opcode) {
+			case OP_LOAD_CONST:
+				if (instruction->operand < 0 || (uint32_t)instruction->operand >= chunk->constant_count)
+					runtime_error("invalid constant index");
+				break;
+			case OP_JUMP:
+			case OP_JUMP_IF_FALSE:
+			case OP_JUMP_IF_TRUE:
+			case OP_LOOP_INC_LT:
+			case OP_JUMP_IF_NOT_LT:
+			case OP_JUMP_IF_NOT_LE: {
+				int64_t target = (int64_t)i + instruction->operand;
+				if (target < 0 || (uint64_t)target >= chunk->code_count)
+					runtime_error("jump target out of range");
+				break;
+			}
+			default:
+				if (instruction->opcode >= OP_COUNT)
+					runtime_error("invalid opcode");
+				break;
+		}
+	}
+}
+
+static void runtime_error(const char *message)
+{
+	fprintf(stderr, "runtime error: %s\n", message);
+	exit(EXIT_FAILURE);
+}
@@ -0,0 +1,28 @@
+#!/bin/bash
+# Times keac on a generated ASCII-only source and on the same source with UTF-8 identifiers. Both repeat a small set of
+# identifiers and numbers, so the time goes into lexing rather than into filling the symbol table.
+# Usage: test/lexer_bench.sh [keac binary] [line count], `make bench` runs it on bin/keac.
+
+set -e
+
+KEAC=${1:-bin/keac}
+LINES=${2:-200000}
+RUNS=3
+OUT=$(dirname "$KEAC")/bench
+
+mkdir -p "$OUT"
+awk -v n="$LINES" 'BEGIN { for (i = 0; i < n; ++i) printf "var value_%d = %d + other_%d * (count - %d);\n", i % 64, i % 64, i % 31, i % 13 }' > "$OUT/ascii.ke"
+awk -v n="$LINES" 'BEGIN { for (i = 0; i < n; ++i) printf "var größe_%d = %d + länge_%d * (anzahl - %d);\n", i % 64, i % 64, i % 31, i % 13 }' > "$OUT/utf8.ke"
+
+TIMEFORMAT=%R
+for input in ascii utf8; do
+	printf "%-6s" "$input"
+	for ((run = 0; run < RUNS; ++run)); do
+		if seconds=$( { time "$KEAC" "$OUT/$input.ke" > /dev/null 2>&1; } 2>&1 ); then
+			printf " %6s s" "$seconds"
+		else
+			printf "  failed"
+		fi
+	done
+	echo
+done
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "vm.h"
+
+#define DEFAULT_ITERATIONS 200000000
+
+// Times for (i = 0; i < n; ++i) sum += i; on the interpreter, once lowered to plain compare, branch and jump
+// instructions and once with the fused loop instructions. `make bench` builds it with both dispatch modes.
+
+// i is R[0], n is R[1] and sum is R[2]
+static void emit_prologue(Chunk *chunk, int64_t iterations)
+{
+	uint32_t zero = vm_add_constant(chunk, 0);
+	uint32_t n = vm_add_constant(chunk, iterations);
+
+	vm_emit(chunk, OP_LOAD_CONST, 0, 0, 0, zero);
+	vm_emit(chunk, OP_LOAD_CONST, 1, 0, 0, n);
+	vm_emit(chunk, OP_LOAD_CONST, 2, 0, 0, zero);
+}
+
+static Chunk *plain_loop(int64_t iterations)
+{
+	Chunk *chunk = vm_chunk_create();
+	emit_prologue(chunk, iterations);
+
+	size_t condition = vm_emit(chunk, OP_LESS_THAN, 3, 0, 1, 0);
+	size_t exit_jump = vm_emit(chunk, OP_JUMP_IF_FALSE, 3, 0, 0, 0);
+	vm_emit(chunk, OP_ADD, 2, 2, 0, 0);
+	vm_emit(chunk, OP_INCREMENT, 0, 0, 0, 0);
+	size_t back_jump = vm_emit(chunk, OP_JUMP, 0, 0, 0, 0);
+	size_t end = vm_emit(chunk, OP_RETURN, 2, 0, 0, 0);
+
+	chunk->code[exit_jump].operand = end - exit_jump;
+	chunk->code[back_jump].operand = (int32_t)condition - (int32_t)back_jump;
+
+	return chunk;
+}
+
+static Chunk *fused_loop(int64_t iterations)
+{
+	Chunk *chunk = vm_chunk_create();
+	emit_prologue(chunk, iterations);
+
+	size_t guard = vm_emit(chunk, OP_JUMP_IF_NOT_LT, 0, 1, 0, 0);
+	size_t body = vm_emit(chunk, OP_ADD, 2, 2, 0, 0);
+	size_t loop = vm_emit(chunk, OP_LOOP_INC_LT, 0, 1, 0, 0);
+	size_t end = vm_emit(chunk, OP_RETURN, 2, 0, 0, 0);
+
+	chunk->code[guard].operand = end - guard;
+	chunk->code[loop].operand = (int32_t)body - (int32_t)loop;
+
+	return chunk;
+}
+
+static void time_chunk(const char *name, Chunk *chunk, int64_t iterations)
+{
+	clock_t start = clock();
+	int64_t result = vm_run(chunk);
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	// The sum is only compared for small loops, larger ones overflow and wrap around
+	if (iterations <= 3000000000 && result != iterations * (iterations - 1) / 2) {
+		fprintf(stderr, "error: %s loop returned %ld\n", name, result);
+		exit(EXIT_FAILURE);
+	}
+
+	printf("%-6s %5zu instructions %8.3f s\n", name, chunk->code_count, seconds);
+	vm_chunk_free(chunk);
+}
+
+int main(int argc, char **argv)
+{
+	int64_t iterations = argc > 1 ? strtoll(argv[1], NULL, 10) : DEFAULT_ITERATIONS;
+	if (iterations < 1) {
+		fprintf(stderr, "error: iteration count must be positive\n");
+		return EXIT_FAILURE;
+	}
+
+	time_chunk("plain", plain_loop(iterations), iterations);
+	time_chunk("fused", fused_loop(iterations), iterations);
+
+	return EXIT_SUCCESS;
+}